@@ -16,6 +16,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include "dist.h"
+#include "sketch.h"
+#include "replay.h"
+#include "output.h"
 
 //
 // station struct
@@ -48,6 +51,63 @@ struct STATION_DIST{
     double distance;
 };
 
+//
+// station ID and its position in the stations array, kept sorted by ID
+// so streaming modes can find a trip's station with a binary search
+//
+struct STATION_INDEX {
+    char* stationID;
+    int index;
+};
+
+//
+// exact aggregates of a trips file, built by the streaming modes without
+// keeping the trips
+//
+struct TRIP_TOTALS {
+    int tripCount;
+    int durationCounts[5];
+    int hourCounts[24];
+    int* stationTrips;          // indexed like the stations array
+};
+
+//
+// the fields of one trip the streaming modes need, parsed from a line
+//
+struct TRIP_RECORD {
+    int startStation;           // position in stations array, -1 if unknown
+    int endStation;
+    int duration;
+    int hour;                   // -1 if missing or out of range
+};
+
+//
+// approximate statistics built by streaming the trips file once
+// (approximate mode). Memory use is fixed by the number of stations and
+// the sketch sizes, not by the number of trips. The totals are exact;
+// the sketches give estimates with the error bounds documented in
+// sketch.h.
+//
+struct APPROX_STATS {
+    struct TRIP_TOTALS totals;
+    struct HLL* bikes;          // distinct bikes overall
+    struct HLL** stationBikes;  // distinct bikes per station
+    struct TDIGEST* durations;  // duration quantiles
+    struct CMS* pairs;          // (start, end) station pair frequencies
+    struct TOPK* topPairs;      // heaviest station pairs
+};
+
+#define APPROX_BIKES_PRECISION 14
+#define APPROX_STATION_BIKES_PRECISION 10
+#define APPROX_DURATION_COMPRESSION 100
+#define APPROX_PAIRS_WIDTH 2048
+#define APPROX_PAIRS_DEPTH 4
+#define APPROX_TOP_PAIRS 10
+
+// HyperLogLog errors are roughly normal, so two standard errors give
+// a bound that holds with about 95% confidence
+#define APPROX_CONFIDENCE_SIGMAS 2.0
+
 /////////////////////
 //
 // PRIVATE FUNCTIONS
@@ -236,6 +296,43 @@ static char* extractRestOfLine(char* current) {
     return result;
 }
 
+//
+// splitFields()
+//
+// splits a line in place into at most maxFields whitespace separated
+// words, storing a pointer to each in fields and returning how many were
+// found. Unlike extractWord() nothing is allocated, so the streaming
+// modes can parse a trip without touching the heap.
+//
+static int splitFields(char* line, char* fields[], int maxFields) {
+    int count = 0;
+    char* current = line;
+    
+    while (count < maxFields) {
+        // Skip whitespace
+        while (*current == ' ' || *current == '\t') current++;
+        
+        if (*current == '\0' || *current == '\n') {
+            break;  // No more words
+        }
+        
+        fields[count] = current;
+        count++;
+        
+        // Find end of word and terminate it
+        while (*current && *current != ' ' && *current != '\t' && *current != '\n') {
+            current++;
+        }
+        if (*current == '\0') {
+            break;
+        }
+        *current = '\0';
+        current++;
+    }
+    
+    return count;
+}
+
 //
 // readStations()
 //
@@ -336,6 +433,272 @@ struct TRIP* readTrips(char* filename, int* count) {
     return trips;
 }
 
+//
+// durationCategory()
+//
+// returns which of the 5 duration categories (0-4) a trip duration
+// in seconds falls into
+//
+static int durationCategory(int duration) {
+    if (duration <= 1800) {                    // <= 30 minutes (1800 seconds)
+        return 0;
+    } else if (duration <= 3600) {             // 30-60 minutes (3600 seconds)
+        return 1;
+    } else if (duration <= 7200) {             // 1-2 hours (7200 seconds)
+        return 2;
+    } else if (duration <= 18000) {            // 2-5 hours (18000 seconds)
+        return 3;
+    } else {                                   // > 5 hours
+        return 4;
+    }
+}
+
+//
+// printDurationCounts()
+//
+// prints the number of trips in each duration category
+//
+static void printDurationCounts(int counts[5]) {
+    // Print results in the exact format required
+    printf("  trips <= 30 mins: %d\n", counts[0]);
+    printf("  trips 30..60 mins: %d\n", counts[1]);
+    printf("  trips 1-2 hrs: %d\n", counts[2]);
+    printf("  trips 2-5 hrs: %d\n", counts[3]);
+    printf("  trips > 5 hrs: %d\n", counts[4]);
+}
+
+//
+// compareStationIndex()
+//
+// orders STATION_INDEX entries by station ID, for qsort and bsearch
+//
+static int compareStationIndex(const void* a, const void* b) {
+    struct STATION_INDEX* entryA = (struct STATION_INDEX*)a;
+    struct STATION_INDEX* entryB = (struct STATION_INDEX*)b;
+    return strcmp(entryA->stationID, entryB->stationID);
+}
+
+//
+// buildStationIndex()
+//
+// returns a dynamically allocated array of the station IDs sorted by ID,
+// each with its position in the stations array
+//
+static struct STATION_INDEX* buildStationIndex(struct STATION* stations, int stationCount) {
+    struct STATION_INDEX* index = malloc((stationCount > 0 ? stationCount : 1) * sizeof(struct STATION_INDEX));
+    
+    for (int i = 0; i < stationCount; i++) {
+        index[i].stationID = stations[i].stationID;
+        index[i].index = i;
+    }
+    
+    qsort(index, stationCount, sizeof(struct STATION_INDEX), compareStationIndex);
+    return index;
+}
+
+//
+// lookupStation()
+//
+// returns the position in the stations array of the station with the
+// given ID, or -1 if there is no such station. If IDs are duplicated the
+// same station is always returned for a given ID.
+//
+static int lookupStation(struct STATION_INDEX* index, int stationCount, char* stationID) {
+    struct STATION_INDEX key;
+    key.stationID = stationID;
+    
+    struct STATION_INDEX* found = bsearch(&key, index, stationCount, sizeof(struct STATION_INDEX), compareStationIndex);
+    return found == NULL ? -1 : found->index;
+}
+
+//
+// createTripTotals / freeTripTotals
+//
+// allocate (zeroed) and free the exact aggregates of the streaming modes
+//
+static struct TRIP_TOTALS* createTripTotals(int stationCount) {
+    struct TRIP_TOTALS* totals = calloc(1, sizeof(struct TRIP_TOTALS));
+    totals->stationTrips = calloc(stationCount > 0 ? stationCount : 1, sizeof(int));
+    return totals;
+}
+
+static void freeTripTotals(struct TRIP_TOTALS* totals) {
+    free(totals->stationTrips);
+    free(totals);
+}
+
+//
+// addTripToTotals()
+//
+// counts one trip, given its stations (-1 if not in the stations file),
+// duration and starting hour (-1 if unknown). A round trip counts once
+// for its station, as in countTripsForStation().
+//
+static void addTripToTotals(struct TRIP_TOTALS* totals, int start, int end, int duration, int hour) {
+    totals->tripCount++;
+    totals->durationCounts[durationCategory(duration)]++;
+    
+    if (hour >= 0 && hour < 24) {
+        totals->hourCounts[hour]++;
+    }
+    if (start >= 0) {
+        totals->stationTrips[start]++;
+    }
+    if (end >= 0 && end != start) {
+        totals->stationTrips[end]++;
+    }
+}
+
+//
+// parseTripRecord()
+//
+// parses one line of the trips file in place into a compact record.
+// Returns 0 if the line is not a trip, using the same rule as
+// readTrips(); bikeID is set to the bike field when it is not NULL.
+//
+static int parseTripRecord(char* line, struct STATION_INDEX* index, int stationCount,
+                           struct TRIP_RECORD* record, char** bikeID) {
+    char* fields[6];
+    
+    // TripID BikeID StartStationID EndStationID Duration StartTime
+    int fieldCount = splitFields(line, fields, 6);
+    if (fieldCount < 5) {
+        return 0;
+    }
+    
+    record->startStation = lookupStation(index, stationCount, fields[2]);
+    record->endStation = lookupStation(index, stationCount, fields[3]);
+    record->duration = atoi(fields[4]);
+    record->hour = -1;
+    if (fieldCount == 6) {
+        int hour = atoi(fields[5]);
+        if (hour >= 0 && hour < 24) {
+            record->hour = hour;
+        }
+    }
+    
+    if (bikeID != NULL) {
+        *bikeID = fields[1];
+    }
+    return 1;
+}
+
+//
+// readTripsExternal()
+//
+// computes the exact totals of the trips file one line at a time,
+// without keeping any trips. Memory use is the stations table, its
+// index, the per-station counters and the current line, whatever the
+// size of the trips file. The results are identical to the in-memory
+// commands.
+//
+static struct TRIP_TOTALS* readTripsExternal(char* filename, struct STATION_INDEX* index, int stationCount) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error: unable to open file \"%s\"\n", filename);
+        return NULL;
+    }
+    
+    struct TRIP_TOTALS* totals = createTripTotals(stationCount);
+    struct TRIP_RECORD record;
+    
+    char* line = NULL;
+    size_t len = 0;
+    
+    while (getline(&line, &len, file) != -1) {
+        if (parseTripRecord(line, index, stationCount, &record, NULL)) {
+            addTripToTotals(totals, record.startStation, record.endStation, record.duration, record.hour);
+        }
+    }
+    
+    free(line);
+    fclose(file);
+    return totals;
+}
+
+//
+// freeApproxStats
+//
+// frees the counters and sketches of approximate mode, and the
+// structure itself
+//
+static void freeApproxStats(struct APPROX_STATS* stats, int stationCount) {
+    for (int i = 0; i < stationCount; i++) {
+        hllFree(stats->stationBikes[i]);
+    }
+    free(stats->stationBikes);
+    free(stats->totals.stationTrips);
+    hllFree(stats->bikes);
+    tdigestFree(stats->durations);
+    cmsFree(stats->pairs);
+    topkFree(stats->topPairs);
+    free(stats);
+}
+
+//
+// readTripsApprox()
+//
+// streams the trips file once without keeping any trips, feeding each
+// one into the counters and sketches of approximate mode. Only the
+// current line is held in memory. Trips are accepted by the same rule
+// as readTrips(); station pairs are only tracked when both stations are
+// in the stations file.
+//
+static struct APPROX_STATS* readTripsApprox(char* filename, struct STATION_INDEX* index, int stationCount) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error: unable to open file \"%s\"\n", filename);
+        return NULL;
+    }
+    
+    struct APPROX_STATS* stats = calloc(1, sizeof(struct APPROX_STATS));
+    stats->totals.stationTrips = calloc(stationCount > 0 ? stationCount : 1, sizeof(int));
+    stats->stationBikes = malloc((stationCount > 0 ? stationCount : 1) * sizeof(struct HLL*));
+    for (int i = 0; i < stationCount; i++) {
+        stats->stationBikes[i] = hllCreate(APPROX_STATION_BIKES_PRECISION);
+    }
+    stats->bikes = hllCreate(APPROX_BIKES_PRECISION);
+    stats->durations = tdigestCreate(APPROX_DURATION_COMPRESSION);
+    stats->pairs = cmsCreate(APPROX_PAIRS_WIDTH, APPROX_PAIRS_DEPTH);
+    stats->topPairs = topkCreate(APPROX_TOP_PAIRS);
+    
+    char* line = NULL;
+    size_t len = 0;
+    struct TRIP_RECORD record;
+    char* bikeID;
+    
+    while (getline(&line, &len, file) != -1) {
+        if (!parseTripRecord(line, index, stationCount, &record, &bikeID)) {
+            continue;
+        }
+        
+        int start = record.startStation;
+        int end = record.endStation;
+        addTripToTotals(&stats->totals, start, end, record.duration, record.hour);
+        tdigestAdd(stats->durations, record.duration);
+        
+        uint64_t bikeHash = hashString(bikeID);
+        hllAdd(stats->bikes, bikeHash);
+        
+        if (start >= 0) {
+            hllAdd(stats->stationBikes[start], bikeHash);
+        }
+        if (end >= 0 && end != start) {
+            hllAdd(stats->stationBikes[end], bikeHash);
+        }
+        
+        if (start >= 0 && end >= 0) {
+            uint64_t pair = ((uint64_t)start << 32) | (uint32_t)end;
+            uint32_t estimate = cmsAdd(stats->pairs, hashMix(pair));
+            topkOffer(stats->topPairs, pair, estimate);
+        }
+    }
+    
+    free(line);
+    fclose(file);
+    return stats;
+}
+
 //
 // printDurations()
 //
@@ -345,27 +708,22 @@ static void printDurations(struct TRIP* trips, int tripCount) {
     int counts[5] = {0}; // Initialize all counts to 0
     
     for (int i = 0; i < tripCount; i++) {
-        int duration = trips[i].duration; // duration is in seconds
-        
-        if (duration <= 1800) {                    // <= 30 minutes (1800 seconds)
-            counts[0]++;
-        } else if (duration <= 3600) {             // 30-60 minutes (3600 seconds)
-            counts[1]++;
-        } else if (duration <= 7200) {             // 1-2 hours (7200 seconds)
-            counts[2]++;
-        } else if (duration <= 18000) {            // 2-5 hours (18000 seconds)
-            counts[3]++;
-        } else {                                   // > 5 hours
-            counts[4]++;
-        }
+        counts[durationCategory(trips[i].duration)]++; // duration is in seconds
     }
     
-    // Print results in the exact format required
-    printf("  trips <= 30 mins: %d\n", counts[0]);
-    printf("  trips 30..60 mins: %d\n", counts[1]);
-    printf("  trips 1-2 hrs: %d\n", counts[2]);
-    printf("  trips 2-5 hrs: %d\n", counts[3]);
-    printf("  trips > 5 hrs: %d\n", counts[4]);
+    printDurationCounts(counts);
+}
+
+//
+// printHourCounts
+//
+// outputs a histogram of trip counts by starting hour (0-23)
+//
+static void printHourCounts(int hourCounts[24]) {
+    // Print histogram for all 24 hours (0-23)
+    for (int i = 0; i < 24; i++) {
+        printf("  %d: %d\n", i, hourCounts[i]);
+    }
 }
 
 //
@@ -382,10 +740,7 @@ static void printStartingTimes(struct TRIP* trips, int tripCount) {
         hourCounts[hour]++;
     }
     
-    // Print histogram for all 24 hours (0-23)
-    for (int i = 0; i < 24; i++) {
-        printf("  %d: %d\n", i, hourCounts[i]);
-    }
+    printHourCounts(hourCounts);
 }
 
 
@@ -402,6 +757,54 @@ static int compareStationsByDistance(const void* a, const void* b) {
 }
 
 
+//
+// printNoneFound()
+//
+// reports an empty listing; in CSV and JSON-lines formats an empty
+// listing is just no rows
+//
+static void printNoneFound(void) {
+    if (outputGetFormat() == OUTPUT_TEXT) {
+        outputString("  none found\n");
+    }
+}
+
+//
+// printNearbyLine()
+//
+// outputs one station found by nearMe() and its distance, in the
+// current output format
+//
+static void printNearbyLine(struct STATION_DIST* nearby) {
+    if (outputGetFormat() == OUTPUT_CSV) {
+        outputCsvField(nearby->station.stationID);
+        outputChar(',');
+        outputCsvField(nearby->station.name);
+        outputChar(',');
+        outputDoubleShortest(nearby->distance);
+        outputChar('\n');
+    }
+    else if (outputGetFormat() == OUTPUT_JSON) {
+        outputString("{\"id\":");
+        outputJsonString(nearby->station.stationID);
+        outputString(",\"name\":");
+        outputJsonString(nearby->station.name);
+        outputString(",\"distance\":");
+        outputJsonNumber(nearby->distance);
+        outputString("}\n");
+    }
+    else {
+        outputString("  station ");
+        outputString(nearby->station.stationID);
+        outputString(" (");
+        outputString(nearby->station.name);
+        outputString("): ");
+        outputDouble(nearby->distance);
+        outputString(" miles\n");
+    }
+}
+
+
 //
 // nearMe()
 //
@@ -414,7 +817,18 @@ static void nearMe(struct STATION* stations, int stationCount, struct TRIP* trip
     // printf("Enter your latitude, longitude, and maximum distance: ");
     // scanf("%lf %lf %lf", &lat, &lon, &maxDist);
 
-    printf("  The following stations are within %g miles of (%g, %g):\n", maxDist, lat, lon);
+    if (outputGetFormat() == OUTPUT_TEXT) {
+        outputString("  The following stations are within ");
+        outputDouble(maxDist);
+        outputString(" miles of (");
+        outputDouble(lat);
+        outputString(", ");
+        outputDouble(lon);
+        outputString("):\n");
+    }
+    else if (outputGetFormat() == OUTPUT_CSV) {
+        outputString("id,name,distance\n");
+    }
 
     int capacity = 10;
     struct STATION_DIST* nearbyStations = malloc(capacity * sizeof(struct STATION_DIST));
@@ -438,20 +852,86 @@ static void nearMe(struct STATION* stations, int stationCount, struct TRIP* trip
 
     //output results - print none found if there are no stations within maxDist
     if (nearbyCount == 0){
-        printf("  none found\n");  // Fixed the typo: removed the ]
+        printNoneFound();
     }
     else{
         for (int i=0; i<nearbyCount; i++){
-            printf("  station %s (%s): %g miles\n",
-                    nearbyStations[i].station.stationID,
-                    nearbyStations[i].station.name,
-                    nearbyStations[i].distance);
+            printNearbyLine(&nearbyStations[i]);
         }
     }
+    outputFlush();
     free(nearbyStations);
 }
 
 
+//
+// printStationHeader()
+//
+// starts a stations or find listing; only CSV has a header row
+//
+static void printStationHeader(void) {
+    if (outputGetFormat() == OUTPUT_CSV) {
+        outputString("name,id,latitude,longitude,capacity,trips\n");
+    }
+}
+
+//
+// printStationLine()
+//
+// outputs one station and its trip count in the format shared by the
+// stations and find commands. Goes through the buffered output layer,
+// so callers must outputFlush() when the listing is done. In CSV and
+// JSON-lines formats coordinates are written in full (shortest round
+// trip) rather than to 6 digits as in the text format.
+//
+static void printStationLine(struct STATION* station, int stationTripCount) {
+    if (outputGetFormat() == OUTPUT_CSV) {
+        outputCsvField(station->name);
+        outputChar(',');
+        outputCsvField(station->stationID);
+        outputChar(',');
+        outputDoubleShortest(station->latitude);
+        outputChar(',');
+        outputDoubleShortest(station->longitude);
+        outputChar(',');
+        outputInt(station->capacity);
+        outputChar(',');
+        outputInt(stationTripCount);
+        outputChar('\n');
+    }
+    else if (outputGetFormat() == OUTPUT_JSON) {
+        outputString("{\"name\":");
+        outputJsonString(station->name);
+        outputString(",\"id\":");
+        outputJsonString(station->stationID);
+        outputString(",\"latitude\":");
+        outputJsonNumber(station->latitude);
+        outputString(",\"longitude\":");
+        outputJsonNumber(station->longitude);
+        outputString(",\"capacity\":");
+        outputInt(station->capacity);
+        outputString(",\"trips\":");
+        outputInt(stationTripCount);
+        outputString("}\n");
+    }
+    else {
+        // "%s (%s) @ (%g, %g), %d capacity, %d trips\n"
+        outputString(station->name);
+        outputString(" (");
+        outputString(station->stationID);
+        outputString(") @ (");
+        outputDouble(station->latitude);
+        outputString(", ");
+        outputDouble(station->longitude);
+        outputString("), ");
+        outputInt(station->capacity);
+        outputString(" capacity, ");
+        outputInt(stationTripCount);
+        outputString(" trips\n");
+    }
+}
+
+
 //
 // compareStationsByName()
 //
@@ -485,17 +965,12 @@ static void printAllStations(struct STATION* stations, int stationCount, struct
     qsort(sortedStations, stationCount, sizeof(struct STATION), compareStationsByName);
 
     // output alphabetically sorted array
+    printStationHeader();
     for (int i = 0; i < stationCount; i++) {
         int stationTripCount = countTripsForStation(sortedStations[i].stationID, trips, tripCount);
-        
-        printf("%s (%s) @ (%g, %g), %d capacity, %d trips\n",
-               sortedStations[i].name,
-               sortedStations[i].stationID,
-               sortedStations[i].latitude,
-               sortedStations[i].longitude,
-               sortedStations[i].capacity,
-               stationTripCount);
+        printStationLine(&sortedStations[i], stationTripCount);
     }
+    outputFlush();
     free(sortedStations);
 }
 
@@ -534,31 +1009,349 @@ static void findStations(struct STATION* stations, int stationCount, struct TRIP
     qsort(matchingStations, matchingCount, sizeof(struct STATION), compareStationsByName);
     
     // Print results or "none found"
+    printStationHeader();
     if (matchingCount == 0) {
-        printf("  none found\n");
+        printNoneFound();
     } else {
         for (int i = 0; i < matchingCount; i++) {
             int stationTripCount = countTripsForStation(matchingStations[i].stationID, trips, tripCount);
-            
-            printf("%s (%s) @ (%g, %g), %d capacity, %d trips\n",
-                   matchingStations[i].name,
-                   matchingStations[i].stationID,
-                   matchingStations[i].latitude,
-                   matchingStations[i].longitude,
-                   matchingStations[i].capacity,
-                   stationTripCount);
+            printStationLine(&matchingStations[i], stationTripCount);
         }
     }
     
     // Remove this line since we don't own searchTerm anymore:
     // free(searchTerm);
+    outputFlush();
     free(matchingStations);
 }
 
 
+//
+// replay output
+//
+
+//
+// parseMinuteOfDay()
+//
+// converts a start time ("H:MM" or "HH:MM") to minutes since midnight,
+// or returns -1 if the time is missing or invalid
+//
+static int parseMinuteOfDay(char* time) {
+    if (time == NULL) {
+        return -1;
+    }
+    
+    char* colon = strchr(time, ':');
+    if (colon == NULL) {
+        return -1;
+    }
+    
+    int hour = atoi(time);
+    int minute = atoi(colon + 1);
+    if (hour < 0 || hour >= 24 || minute < 0 || minute >= 60) {
+        return -1;
+    }
+    return hour * 60 + minute;
+}
+
+//
+// replayTrips()
+//
+// converts each trip into a departure from its start station at its
+// start time and an arrival at its end station duration later (wrapped
+// into the same day, as a daily profile), orders the events by minute
+// with a counting sort and replays them. Trips without a valid start
+// time are skipped; otherwise only an end whose station is not in the
+// stations file is dropped, and the other end still counts. Runs in
+// time linear in the number of trips.
+//
+static struct REPLAY* replayTrips(struct STATION* stations, int stationCount, struct TRIP* trips, int tripCount,
+                                  struct STATION_INDEX* index) {
+    int eventCapacity = 2 * tripCount > 0 ? 2 * tripCount : 1;
+    struct EVENT* events = malloc(eventCapacity * sizeof(struct EVENT));
+    int eventCount = 0;
+    
+    for (int i = 0; i < tripCount; i++) {
+        int minute = parseMinuteOfDay(trips[i].startTime);
+        if (minute < 0) {
+            continue;
+        }
+        
+        int start = lookupStation(index, stationCount, trips[i].startStationID);
+        int end = lookupStation(index, stationCount, trips[i].endStationID);
+        
+        if (start >= 0) {
+            events[eventCount].station = start;
+            events[eventCount].minute = minute;
+            events[eventCount].arrival = 0;
+            eventCount++;
+        }
+        if (end >= 0) {
+            events[eventCount].station = end;
+            // a negative duration must still land on a minute of the day
+            int arrival = (minute + trips[i].duration / 60) % MINUTES_PER_DAY;
+            events[eventCount].minute = (arrival + MINUTES_PER_DAY) % MINUTES_PER_DAY;
+            events[eventCount].arrival = 1;
+            eventCount++;
+        }
+    }
+    
+    struct EVENT* sorted = malloc(eventCapacity * sizeof(struct EVENT));
+    sortEventsByMinute(events, eventCount, sorted);
+    free(events);
+    
+    int* capacities = malloc((stationCount > 0 ? stationCount : 1) * sizeof(int));
+    for (int i = 0; i < stationCount; i++) {
+        capacities[i] = stations[i].capacity;
+    }
+    
+    struct REPLAY* replay = replayEvents(sorted, eventCount, capacities, stationCount);
+    
+    free(capacities);
+    free(sorted);
+    return replay;
+}
+
+//
+// printFlow()
+//
+// replays the trips and outputs, for the station with the given ID, the
+// net flow of bikes (arrivals - departures) in each hour and the
+// estimated number of bikes at the end of that hour
+//
+static void printFlow(struct STATION* stations, int stationCount, struct TRIP* trips, int tripCount, char* stationID) {
+    struct STATION_INDEX* index = buildStationIndex(stations, stationCount);
+    int station = lookupStation(index, stationCount, stationID);
+    
+    if (station < 0) {
+        printf("  none found\n");
+        free(index);
+        return;
+    }
+    
+    struct REPLAY* replay = replayTrips(stations, stationCount, trips, tripCount, index);
+    
+    printf("  %s (%s), %d capacity, assumed to start with %d bikes:\n",
+           stations[station].name,
+           stations[station].stationID,
+           stations[station].capacity,
+           replay->startOccupancy[station]);
+    for (int hour = 0; hour < 24; hour++) {
+        printf("  %d: net flow %+d, %d bikes\n", hour,
+               replay->hourlyNetFlow[station * 24 + hour],
+               replay->hourlyOccupancy[station * 24 + hour]);
+    }
+    
+    freeReplay(replay);
+    free(index);
+}
+
+//
+// printEmptyFull()
+//
+// replays the trips and outputs, alphabetically, the stations whose
+// estimated occupancy runs down to empty or up to capacity, with the
+// first time each happens
+//
+static void printEmptyFull(struct STATION* stations, int stationCount, struct TRIP* trips, int tripCount) {
+    struct STATION_INDEX* index = buildStationIndex(stations, stationCount);
+    struct REPLAY* replay = replayTrips(stations, stationCount, trips, tripCount, index);
+    
+    struct STATION* sortedStations = malloc((stationCount > 0 ? stationCount : 1) * sizeof(struct STATION));
+    for (int i = 0; i < stationCount; i++) {
+        sortedStations[i] = stations[i];
+    }
+    qsort(sortedStations, stationCount, sizeof(struct STATION), compareStationsByName);
+    
+    int found = 0;
+    for (int i = 0; i < stationCount; i++) {
+        int station = lookupStation(index, stationCount, sortedStations[i].stationID);
+        int empty = replay->emptyMinute[station];
+        int full = replay->fullMinute[station];
+        
+        if (empty < 0 && full < 0) {
+            continue;
+        }
+        
+        printf("  %s (%s), %d capacity:", sortedStations[i].name, sortedStations[i].stationID,
+               sortedStations[i].capacity);
+        if (empty >= 0) {
+            printf(" empty at %d:%02d", empty / 60, empty % 60);
+        }
+        if (full >= 0) {
+            printf("%s full at %d:%02d", empty >= 0 ? "," : "", full / 60, full % 60);
+        }
+        printf("\n");
+        found++;
+    }
+    
+    if (found == 0) {
+        printf("  none found\n");
+    }
+    
+    free(sortedStations);
+    freeReplay(replay);
+    free(index);
+}
+
+
+//
+// streaming mode output
+//
+
+//
+// printApproxStats()
+//
+// outputs the estimated number of distinct bikes, after the stats report
+//
+static void printApproxStats(struct APPROX_STATS* stats) {
+    printf("  distinct bikes: ~%.0f (+/- %.2f%% with 95%% confidence)\n",
+           hllEstimate(stats->bikes),
+           100.0 * APPROX_CONFIDENCE_SIGMAS * hllRelativeError(stats->bikes));
+}
+
+//
+// printApproxDurations()
+//
+// outputs estimated duration quantiles from the t-digest, after the
+// (exact) duration categories
+//
+static void printApproxDurations(struct APPROX_STATS* stats) {
+    if (stats->totals.tripCount == 0) {
+        return;
+    }
+    
+    double quantiles[] = {0.5, 0.9, 0.99};
+    const char* labels[] = {"median", "90th percentile", "99th percentile"};
+    
+    printf("  shortest trip: %.0f secs\n", tdigestQuantile(stats->durations, 0.0));
+    for (int i = 0; i < 3; i++) {
+        printf("  %s: ~%.0f secs\n", labels[i], tdigestQuantile(stats->durations, quantiles[i]));
+    }
+    printf("  longest trip: %.0f secs\n", tdigestQuantile(stats->durations, 1.0));
+}
+
+//
+// printStationsCounted()
+//
+// outputs stations alphabetically with trip counts taken from a
+// per-station counts array rather than from the trips. Only stations
+// whose name contains searchTerm are printed, unless it is NULL.
+//
+static void printStationsCounted(struct STATION* stations, int stationCount, struct STATION_INDEX* index,
+                                 int* stationTrips, char* searchTerm) {
+    struct STATION* sortedStations = malloc((stationCount > 0 ? stationCount : 1) * sizeof(struct STATION));
+    int sortedCount = 0;
+    
+    for (int i = 0; i < stationCount; i++) {
+        if (searchTerm == NULL || strstr(stations[i].name, searchTerm) != NULL) {
+            sortedStations[sortedCount] = stations[i];
+            sortedCount++;
+        }
+    }
+    
+    qsort(sortedStations, sortedCount, sizeof(struct STATION), compareStationsByName);
+    
+    printStationHeader();
+    if (searchTerm != NULL && sortedCount == 0) {
+        printNoneFound();
+    }
+    for (int i = 0; i < sortedCount; i++) {
+        // look up by ID so duplicated IDs share one count, like countTripsForStation()
+        int station = lookupStation(index, stationCount, sortedStations[i].stationID);
+        printStationLine(&sortedStations[i], stationTrips[station]);
+    }
+    outputFlush();
+    
+    free(sortedStations);
+}
+
+//
+// printApproxBikes()
+//
+// outputs the estimated number of distinct bikes that started or ended
+// a trip at each station, alphabetically by station name
+//
+static void printApproxBikes(struct STATION* stations, int stationCount, struct STATION_INDEX* index,
+                             struct APPROX_STATS* stats) {
+    struct STATION* sortedStations = malloc((stationCount > 0 ? stationCount : 1) * sizeof(struct STATION));
+    
+    for (int i = 0; i < stationCount; i++) {
+        sortedStations[i] = stations[i];
+    }
+    
+    qsort(sortedStations, stationCount, sizeof(struct STATION), compareStationsByName);
+    
+    for (int i = 0; i < stationCount; i++) {
+        int station = lookupStation(index, stationCount, sortedStations[i].stationID);
+        printf("  %s (%s): ~%.0f bikes\n",
+               sortedStations[i].name,
+               sortedStations[i].stationID,
+               hllEstimate(stats->stationBikes[station]));
+    }
+    if (stationCount > 0) {
+        printf("  (each estimate +/- %.2f%% with 95%% confidence)\n",
+               100.0 * APPROX_CONFIDENCE_SIGMAS * hllRelativeError(stats->stationBikes[0]));
+    }
+    
+    free(sortedStations);
+}
+
+//
+// printApproxPairs()
+//
+// outputs the heaviest (start, end) station pairs with their
+// count-min estimates, largest first
+//
+static void printApproxPairs(struct STATION* stations, struct APPROX_STATS* stats) {
+    topkSort(stats->topPairs);
+    
+    if (stats->topPairs->count == 0) {
+        printf("  none found\n");
+        return;
+    }
+    
+    for (int i = 0; i < stats->topPairs->count; i++) {
+        int start = (int)(stats->topPairs->keys[i] >> 32);
+        int end = (int)(uint32_t)stats->topPairs->keys[i];
+        printf("  %s (%s) -> %s (%s): ~%u trips\n",
+               stations[start].name, stations[start].stationID,
+               stations[end].name, stations[end].stationID,
+               (unsigned)stats->topPairs->estimates[i]);
+    }
+    printf("  (estimates overcount by at most %.0f trips with 98%% confidence)\n",
+           cmsErrorBound(stats->pairs));
+}
+
+
 /////////////////////////////////////////////////////////
 
 
+//
+// readCommand()
+//
+// prompts for and reads one command line into the reusable command
+// buffer, doubling the buffer when needed. Returns the (possibly moved)
+// buffer.
+//
+static char* readCommand(char* command, int* commandCapacity) {
+    // Read command dynamically (your original way)
+    printf("Enter command (# to stop)>\n");
+    int length = 0;
+    int c;
+    
+    while ((c = getchar()) != '\n' && c != EOF) {
+        if (length >= *commandCapacity - 1) {
+            command = doubleCharArray(command, commandCapacity);
+        }
+        command[length] = c;
+        length++;
+    }
+    command[length] = '\0';
+    return command;
+}
+
+
 //
 // processCommands()
 //
@@ -571,19 +1364,7 @@ static void processCommands(struct STATION* stations, int stationCount, struct T
     char* command = malloc(commandCapacity * sizeof(char));
     
     while (1) {
-        // Read command dynamically (your original way)
-        printf("Enter command (# to stop)>\n");
-        int length = 0;
-        int c;
-        
-        while ((c = getchar()) != '\n' && c != EOF) {
-            if (length >= commandCapacity - 1) {
-                command = doubleCharArray(command, &commandCapacity);
-            }
-            command[length] = c;
-            length++;
-        }
-        command[length] = '\0';
+        command = readCommand(command, &commandCapacity);
         
         // Process commands
         if (strcmp(command, "#") == 0) {
@@ -613,6 +1394,92 @@ static void processCommands(struct STATION* stations, int stationCount, struct T
             char* searchTerm = command + 5;  // Point to the part after "find "
             findStations(stations, stationCount, trips, tripCount, searchTerm);
         }
+        else if (strncmp(command, "flow ", 5) == 0) {
+            printFlow(stations, stationCount, trips, tripCount, command + 5);
+        }
+        else if (strcmp(command, "emptyfull") == 0) {
+            printEmptyFull(stations, stationCount, trips, tripCount);
+        }
+        else if (strcmp(command, "format text") == 0) {
+            outputSetFormat(OUTPUT_TEXT);
+        }
+        else if (strcmp(command, "format csv") == 0) {
+            outputSetFormat(OUTPUT_CSV);
+        }
+        else if (strcmp(command, "format json") == 0) {
+            outputSetFormat(OUTPUT_JSON);
+        }
+        else{
+            printf("** Invalid command, try again...\n\n");
+        }
+    }
+    
+    free(command);
+}
+
+
+//
+// processStreamCommands()
+//
+// command loop for the streaming modes: same commands as
+// processCommands(), answered from the streamed totals. In approximate
+// mode (stats not NULL) stats and durations also report sketch estimates,
+// and "bikes" and "pairs" are available.
+//
+static void processStreamCommands(struct STATION* stations, int stationCount, struct STATION_INDEX* index,
+                                  struct TRIP_TOTALS* totals, struct APPROX_STATS* stats){
+    int commandCapacity = 10;
+    char* command = malloc(commandCapacity * sizeof(char));
+    
+    while (1) {
+        command = readCommand(command, &commandCapacity);
+        
+        if (strcmp(command, "#") == 0) {
+            printf("\n");
+            printf("** Done **\n");
+            break;
+        }
+        else if (strcmp(command, "stats") == 0) {
+            printStats(stations, stationCount, NULL, totals->tripCount);
+            if (stats != NULL) {
+                printApproxStats(stats);
+            }
+        }
+        else if (strcmp(command, "durations") == 0) {
+            printDurationCounts(totals->durationCounts);
+            if (stats != NULL) {
+                printApproxDurations(stats);
+            }
+        }
+        else if (strcmp(command, "starting") == 0) {
+            printHourCounts(totals->hourCounts);
+        }
+        else if (strncmp(command, "nearme ", 7) == 0) {
+            double lat, lon, maxDist;
+            sscanf(command + 7, "%lf %lf %lf", &lat, &lon, &maxDist);
+            nearMe(stations, stationCount, NULL, 0, lat, lon, maxDist);
+        }
+        else if (strcmp(command, "stations") == 0) {
+            printStationsCounted(stations, stationCount, index, totals->stationTrips, NULL);
+        }
+        else if (strncmp(command, "find ", 5) == 0) {
+            printStationsCounted(stations, stationCount, index, totals->stationTrips, command + 5);
+        }
+        else if (stats != NULL && strcmp(command, "bikes") == 0) {
+            printApproxBikes(stations, stationCount, index, stats);
+        }
+        else if (stats != NULL && strcmp(command, "pairs") == 0) {
+            printApproxPairs(stations, stats);
+        }
+        else if (strcmp(command, "format text") == 0) {
+            outputSetFormat(OUTPUT_TEXT);
+        }
+        else if (strcmp(command, "format csv") == 0) {
+            outputSetFormat(OUTPUT_CSV);
+        }
+        else if (strcmp(command, "format json") == 0) {
+            outputSetFormat(OUTPUT_JSON);
+        }
         else{
             printf("** Invalid command, try again...\n\n");
         }
@@ -622,12 +1489,74 @@ static void processCommands(struct STATION* stations, int stationCount, struct T
 }
 
 
+//
+// runApprox()
+//
+// approximate mode: streams the trips file once into fixed-size
+// sketches instead of loading it, then processes commands
+//
+static int runApprox(struct STATION* stations, int stationCount, char* tripsFile) {
+    struct STATION_INDEX* index = buildStationIndex(stations, stationCount);
+    
+    struct APPROX_STATS* stats = readTripsApprox(tripsFile, index, stationCount);
+    if (stats == NULL) {
+        free(index);
+        return 1;
+    }
+    
+    processStreamCommands(stations, stationCount, index, &stats->totals, stats);
+    
+    freeApproxStats(stats, stationCount);
+    free(index);
+    return 0;
+}
+
+
+//
+// runExternal()
+//
+// external mode: streams the trips file once into exact totals instead
+// of loading it, then processes commands
+//
+static int runExternal(struct STATION* stations, int stationCount, char* tripsFile) {
+    struct STATION_INDEX* index = buildStationIndex(stations, stationCount);
+    
+    struct TRIP_TOTALS* totals = readTripsExternal(tripsFile, index, stationCount);
+    if (totals == NULL) {
+        free(index);
+        return 1;
+    }
+    
+    processStreamCommands(stations, stationCount, index, totals, NULL);
+    
+    freeTripTotals(totals);
+    free(index);
+    return 0;
+}
+
+
 //
 // main()
 //
-// handles file input and program execution between all helpers
+// handles file input and program execution between all helpers.
+// Instead of loading every trip, run with -approx to stream the trips
+// file into fixed-size sketches, or with -external to stream it into
+// exact totals (see processStreamCommands()).
 //
-int main(){
+int main(int argc, char* argv[]){
+    int approx = 0;
+    int external = 0;
+    if (argc == 2 && strcmp(argv[1], "-approx") == 0) {
+        approx = 1;
+    }
+    else if (argc == 2 && strcmp(argv[1], "-external") == 0) {
+        external = 1;
+    }
+    else if (argc > 1) {
+        printf("usage: %s [-approx | -external]\n", argv[0]);
+        return 1;
+    }
+    
     printf("** Divvy Bike Data Analysis **\n\n");
     char* stationsFile = readStringInput("Please enter name of stations file>\n"); 
     char* tripsFile = readStringInput("Please enter name of bike trips file>\n");   
@@ -642,6 +1571,15 @@ int main(){
         return 1;
     }
     
+    if (approx || external) {
+        int result = approx ? runApprox(stations, stationCount, tripsFile)
+                            : runExternal(stations, stationCount, tripsFile);
+        freeStations(stations, stationCount);
+        free(stationsFile);
+        free(tripsFile);
+        return result;
+    }
+    
     struct TRIP* trips = readTrips(tripsFile, &tripCount);
     if (trips == NULL) {
         freeStations(stations, stationCount);
@@ -0,0 +1,339 @@
+/*output.c*/
+
+//
+// Buffered output layer for the station listings, with fast double
+// formatting and CSV / JSON-lines export formats.
+//
+// Author:
+// Aarya Patel
+//
+// Northwestern University
+// DIVVY Data analysis
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "output.h"
+
+#define OUTPUT_BUFFER_SIZE 65536
+
+static char outputBuffer[OUTPUT_BUFFER_SIZE];
+static int outputLength = 0;
+static enum OUTPUT_FORMAT outputFormat = OUTPUT_TEXT;
+
+// exactly representable powers of ten
+static const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+void outputSetFormat(enum OUTPUT_FORMAT format) {
+    outputFormat = format;
+}
+
+enum OUTPUT_FORMAT outputGetFormat(void) {
+    return outputFormat;
+}
+
+
+//
+// double formatting
+//
+
+//
+// scaleToDigits
+//
+// rounds a (positive, in [1e-5, 1e15)) to precision significant
+// digits, returning them as an integer along with the decimal
+// exponent of the rounded value. The scaling is a single multiply or
+// divide by an exact power of ten in long double, so the scaled value
+// is off by far less than tolerance; if it still lands too close to a
+// rounding boundary to tell which way printf would round, or the
+// exponent was misjudged, returns 0 so the caller can fall back.
+//
+static int scaleToDigits(double a, int precision, long long* digits, int* exponent) {
+    if (!(a >= 1e-5 && a < 1e15)) {
+        return 0;
+    }
+
+    long double value = a;
+    int e = 0;
+    if (a >= 1.0) {
+        while (value >= POWERS_OF_TEN[e + 1]) e++;
+    }
+    else {
+        e = -1;
+        while (value * POWERS_OF_TEN[-e] < 1.0L) e--;
+    }
+
+    int k = precision - 1 - e;
+    long double scaled = k >= 0 ? value * POWERS_OF_TEN[k] : value / POWERS_OF_TEN[-k];
+
+    long long low = (long long)POWERS_OF_TEN[precision - 1];
+    long long high = (long long)POWERS_OF_TEN[precision];
+    long long whole = (long long)scaled;
+    if (whole < low || whole >= high) {
+        return 0;
+    }
+
+    long double fraction = scaled - whole;
+    long double tolerance = scaled * LDBL_EPSILON * 4;
+    if (fabsl(fraction - 0.5L) <= tolerance) {
+        return 0;
+    }
+
+    if (fraction > 0.5L) {
+        whole++;
+        if (whole == high) {
+            whole /= 10;
+            e++;
+        }
+    }
+
+    *digits = whole;
+    *exponent = e;
+    return 1;
+}
+
+//
+// layoutDigits
+//
+// writes precision significant digits with the given decimal exponent
+// following the %g rules for that precision: fixed notation when
+// -4 <= exponent < precision, otherwise d.ddde+XX, and in both cases
+// without trailing zeros
+//
+static int layoutDigits(char* buf, int negative, long long digits, int precision, int exponent) {
+    char d[20];
+    for (int i = precision - 1; i >= 0; i--) {
+        d[i] = (char)('0' + digits % 10);
+        digits /= 10;
+    }
+
+    int significant = precision;
+    while (significant > 1 && d[significant - 1] == '0') {
+        significant--;
+    }
+
+    char* p = buf;
+    if (negative) {
+        *p++ = '-';
+    }
+
+    if (exponent < -4 || exponent >= precision) {
+        *p++ = d[0];
+        if (significant > 1) {
+            *p++ = '.';
+            memcpy(p, d + 1, significant - 1);
+            p += significant - 1;
+        }
+        *p++ = 'e';
+        *p++ = exponent < 0 ? '-' : '+';
+        int magnitude = exponent < 0 ? -exponent : exponent;
+        if (magnitude >= 100) {
+            *p++ = (char)('0' + magnitude / 100);
+            magnitude %= 100;
+        }
+        *p++ = (char)('0' + magnitude / 10);
+        *p++ = (char)('0' + magnitude % 10);
+    }
+    else if (exponent >= 0) {
+        memcpy(p, d, exponent + 1);
+        p += exponent + 1;
+        if (significant > exponent + 1) {
+            *p++ = '.';
+            memcpy(p, d + exponent + 1, significant - exponent - 1);
+            p += significant - exponent - 1;
+        }
+    }
+    else {
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = 0; i < -exponent - 1; i++) {
+            *p++ = '0';
+        }
+        memcpy(p, d, significant);
+        p += significant;
+    }
+
+    *p = '\0';
+    return (int)(p - buf);
+}
+
+int formatDouble(char* buf, double x) {
+    long long digits;
+    int exponent;
+
+    if (isfinite(x) && x != 0.0 && scaleToDigits(fabs(x), 6, &digits, &exponent)) {
+        return layoutDigits(buf, x < 0.0, digits, 6, exponent);
+    }
+    return snprintf(buf, 32, "%g", x);
+}
+
+int formatDoubleShortest(char* buf, double x) {
+    long long digits;
+    int exponent;
+
+    // Any double has at most one decimal of up to 15 significant digits
+    // that reads back as it, so if the 15 digit rounding reads back
+    // exactly, dropping its trailing zeros gives the shortest string.
+    // digits < 2^53 and the power of ten is exact, so the multiply or
+    // divide below is correctly rounded, just like strtod.
+    if (isfinite(x) && x != 0.0 && scaleToDigits(fabs(x), 15, &digits, &exponent)) {
+        int k = exponent - 14;
+        double back = k >= 0 ? (double)digits * POWERS_OF_TEN[k] : (double)digits / POWERS_OF_TEN[-k];
+        if (back == fabs(x)) {
+            return layoutDigits(buf, x < 0.0, digits, 15, exponent);
+        }
+    }
+
+    // subnormals have fewer significant bits, so may need fewer digits
+    int precision = fabs(x) < DBL_MIN ? 1 : 15;
+    for (; precision < 17; precision++) {
+        int length = snprintf(buf, 32, "%.*g", precision, x);
+        if (strtod(buf, NULL) == x || !isfinite(x)) {
+            return length;
+        }
+    }
+    return snprintf(buf, 32, "%.17g", x);
+}
+
+
+//
+// buffered output
+//
+
+void outputFlush(void) {
+    if (outputLength > 0) {
+        fwrite(outputBuffer, 1, outputLength, stdout);
+        outputLength = 0;
+    }
+}
+
+//
+// outputReserve
+//
+// returns a pointer to room for n more bytes in the buffer (n must not
+// exceed the buffer size), flushing first if there is not enough room
+//
+static char* outputReserve(int n) {
+    if (outputLength + n > OUTPUT_BUFFER_SIZE) {
+        outputFlush();
+    }
+    return outputBuffer + outputLength;
+}
+
+static void outputBytes(const char* s, int n) {
+    if (outputLength + n > OUTPUT_BUFFER_SIZE) {
+        outputFlush();
+        if (n > OUTPUT_BUFFER_SIZE) {
+            fwrite(s, 1, n, stdout);
+            return;
+        }
+    }
+    memcpy(outputBuffer + outputLength, s, n);
+    outputLength += n;
+}
+
+void outputChar(char c) {
+    *outputReserve(1) = c;
+    outputLength++;
+}
+
+void outputString(const char* s) {
+    outputBytes(s, (int)strlen(s));
+}
+
+void outputInt(int value) {
+    char digits[12];
+    int n = 0;
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+
+    do {
+        digits[n++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    char* p = outputReserve(n + 1);
+    int length = 0;
+    if (value < 0) {
+        p[length++] = '-';
+    }
+    while (n > 0) {
+        p[length++] = digits[--n];
+    }
+    outputLength += length;
+}
+
+void outputDouble(double x) {
+    outputLength += formatDouble(outputReserve(32), x);
+}
+
+void outputDoubleShortest(double x) {
+    outputLength += formatDoubleShortest(outputReserve(32), x);
+}
+
+//
+// outputCsvField
+//
+// fields containing a comma, quote or line break are quoted, with
+// quotes doubled (RFC 4180)
+//
+void outputCsvField(const char* s) {
+    if (strpbrk(s, ",\"\r\n") == NULL) {
+        outputString(s);
+        return;
+    }
+
+    outputChar('"');
+    for (; *s != '\0'; s++) {
+        if (*s == '"') {
+            outputChar('"');
+        }
+        outputChar(*s);
+    }
+    outputChar('"');
+}
+
+void outputJsonString(const char* s) {
+    outputChar('"');
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char)*s;
+
+        if (c == '"' || c == '\\') {
+            outputChar('\\');
+            outputChar((char)c);
+        }
+        else if (c == '\n') {
+            outputString("\\n");
+        }
+        else if (c == '\r') {
+            outputString("\\r");
+        }
+        else if (c == '\t') {
+            outputString("\\t");
+        }
+        else if (c < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            outputString(escape);
+        }
+        else {
+            outputChar((char)c);
+        }
+    }
+    outputChar('"');
+}
+
+void outputJsonNumber(double x) {
+    if (!isfinite(x)) {
+        outputString("null");
+        return;
+    }
+    outputDoubleShortest(x);
+}
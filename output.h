@@ -0,0 +1,70 @@
+/*output.h*/
+
+//
+// Buffered output layer for the station listings: rows are formatted
+// into one large reusable buffer that is written with a single fwrite
+// when full or flushed, instead of one printf per row. Supports the
+// human-readable text format plus CSV and JSON-lines export formats.
+//
+// Author:
+// Aarya Patel
+//
+// Northwestern University
+// DIVVY Data analysis
+//
+
+#pragma once
+
+
+enum OUTPUT_FORMAT {
+    OUTPUT_TEXT,
+    OUTPUT_CSV,
+    OUTPUT_JSON
+};
+
+//
+// outputSetFormat / outputGetFormat
+//
+// select or query the format used for station listings (text by
+// default)
+//
+void outputSetFormat(enum OUTPUT_FORMAT format);
+enum OUTPUT_FORMAT outputGetFormat(void);
+
+
+//
+// formatDouble
+//
+// Writes x into buf (at least 32 chars) exactly as printf("%g", x)
+// would, and returns the length. Values are rounded to 6 significant
+// digits with integer arithmetic on a scaled value; the rare cases
+// that fall too close to a rounding boundary to decide this way, or
+// are out of range, are handed to snprintf.
+//
+int formatDouble(char* buf, double x);
+
+//
+// formatDoubleShortest
+//
+// Writes the shortest decimal string that reads back as exactly x
+// (using the same layout as %g), and returns the length. Values with
+// up to 15 significant digits, such as coordinates read from a file,
+// take a fast path that is checked exactly; others fall back to
+// snprintf with 16 or 17 digits.
+//
+int formatDoubleShortest(char* buf, double x);
+
+
+//
+// buffered writes to stdout. Anything written here must be flushed
+// with outputFlush() before writing to stdout in any other way.
+//
+void outputChar(char c);
+void outputString(const char* s);
+void outputInt(int value);
+void outputDouble(double x);            // as %g
+void outputDoubleShortest(double x);    // shortest round trip
+void outputCsvField(const char* s);     // quoted only if needed
+void outputJsonString(const char* s);   // quoted and escaped
+void outputJsonNumber(double x);        // shortest round trip, null if not finite
+void outputFlush(void);
@@ -0,0 +1,123 @@
+/*replay.c*/
+
+//
+// Time-ordered replay of trips as departure and arrival events, to
+// follow how bikes flow through each station over a day.
+//
+// Author:
+// Aarya Patel
+//
+// Northwestern University
+// DIVVY Data analysis
+//
+
+#include <stdlib.h>
+
+#include "replay.h"
+
+
+//
+// eventKey
+//
+// counting sort key: minute of the day, then arrivals (0) before
+// departures (1)
+//
+static int eventKey(struct EVENT* event) {
+    return event->minute * 2 + (event->arrival ? 0 : 1);
+}
+
+void sortEventsByMinute(struct EVENT* events, int count, struct EVENT* sorted) {
+    int starts[2 * MINUTES_PER_DAY + 1] = {0};
+
+    // count each key, then turn the counts into starting positions
+    for (int i = 0; i < count; i++) {
+        starts[eventKey(&events[i]) + 1]++;
+    }
+    for (int key = 0; key < 2 * MINUTES_PER_DAY; key++) {
+        starts[key + 1] += starts[key];
+    }
+
+    // place events in input order, which keeps the sort stable
+    for (int i = 0; i < count; i++) {
+        sorted[starts[eventKey(&events[i])]++] = events[i];
+    }
+}
+
+struct REPLAY* replayEvents(struct EVENT* sorted, int count, int* capacities, int stationCount) {
+    int n = stationCount > 0 ? stationCount : 1;
+
+    struct REPLAY* replay = malloc(sizeof(struct REPLAY));
+    replay->stationCount = stationCount;
+    replay->startOccupancy = malloc(n * sizeof(int));
+    replay->hourlyNetFlow = calloc(n * 24, sizeof(int));
+    replay->hourlyOccupancy = malloc(n * 24 * sizeof(int));
+    replay->emptyMinute = malloc(n * sizeof(int));
+    replay->fullMinute = malloc(n * sizeof(int));
+
+    int* occupancy = malloc(n * sizeof(int));
+
+    for (int s = 0; s < stationCount; s++) {
+        replay->startOccupancy[s] = capacities[s] / 2;
+        occupancy[s] = replay->startOccupancy[s];
+        replay->emptyMinute[s] = -1;
+        replay->fullMinute[s] = -1;
+    }
+
+    for (int i = 0; i < n * 24; i++) {
+        replay->hourlyOccupancy[i] = -1;    // no events in that hour yet
+    }
+
+    // sweep the day in order, one event at a time. Net flow is the raw
+    // balance; occupancy is kept within 0..capacity, since a station
+    // can't go below empty or above full (the trips of several days are
+    // all replayed onto one day, so the raw balance can drift further).
+    for (int i = 0; i < count; i++) {
+        int s = sorted[i].station;
+        int hour = sorted[i].minute / 60;
+
+        if (sorted[i].arrival) {
+            replay->hourlyNetFlow[s * 24 + hour]++;
+            if (occupancy[s] < capacities[s]) {
+                occupancy[s]++;
+            }
+            if (occupancy[s] >= capacities[s] && replay->fullMinute[s] == -1) {
+                replay->fullMinute[s] = sorted[i].minute;
+            }
+        }
+        else {
+            replay->hourlyNetFlow[s * 24 + hour]--;
+            if (occupancy[s] > 0) {
+                occupancy[s]--;
+            }
+            if (occupancy[s] <= 0 && replay->emptyMinute[s] == -1) {
+                replay->emptyMinute[s] = sorted[i].minute;
+            }
+        }
+
+        replay->hourlyOccupancy[s * 24 + hour] = occupancy[s];
+    }
+
+    // hours without events keep the occupancy of the hour before
+    for (int s = 0; s < stationCount; s++) {
+        int bikes = replay->startOccupancy[s];
+        for (int hour = 0; hour < 24; hour++) {
+            if (replay->hourlyOccupancy[s * 24 + hour] < 0) {
+                replay->hourlyOccupancy[s * 24 + hour] = bikes;
+            }
+            bikes = replay->hourlyOccupancy[s * 24 + hour];
+        }
+    }
+
+    free(occupancy);
+    return replay;
+}
+
+void freeReplay(struct REPLAY* replay) {
+    if (replay == NULL) return;
+    free(replay->startOccupancy);
+    free(replay->hourlyNetFlow);
+    free(replay->hourlyOccupancy);
+    free(replay->emptyMinute);
+    free(replay->fullMinute);
+    free(replay);
+}
@@ -0,0 +1,65 @@
+/*replay.h*/
+
+//
+// Time-ordered replay of trips as departure and arrival events, to
+// follow how bikes flow through each station over a day.
+//
+// Author:
+// Aarya Patel
+//
+// Northwestern University
+// DIVVY Data analysis
+//
+
+#pragma once
+
+#define MINUTES_PER_DAY 1440
+
+
+//
+// one bike leaving (departure) or docking (arrival) at a station,
+// at a minute of the day (0..1439)
+//
+struct EVENT {
+    int station;
+    int minute;
+    int arrival;    // 1 for an arrival, 0 for a departure
+};
+
+//
+// per-station results of a replay. Occupancy is an estimate: the
+// trips say nothing about how many bikes a station starts the day
+// with, so every station is assumed to start half full. Occupancy is
+// kept within 0..capacity; net flow is the raw balance of events.
+//
+struct REPLAY {
+    int stationCount;
+    int* startOccupancy;    // bikes at midnight
+    int* hourlyNetFlow;     // arrivals - departures, stationCount x 24
+    int* hourlyOccupancy;   // bikes at the end of each hour, stationCount x 24
+    int* emptyMinute;       // first minute the station has no bikes, -1 if never
+    int* fullMinute;        // first minute the station is at capacity, -1 if never
+};
+
+
+//
+// sortEventsByMinute
+//
+// Copies events into sorted, ordered by minute of the day with arrivals
+// before departures within a minute (so a docked bike can leave again
+// in the same minute). Uses a stable counting sort over the 2 * 1440
+// possible keys, so it runs in linear time.
+//
+void sortEventsByMinute(struct EVENT* events, int count, struct EVENT* sorted);
+
+//
+// replayEvents
+//
+// Sweeps events that are sorted by sortEventsByMinute(), tracking
+// each station's estimated occupancy against its capacity. Event
+// minutes must be in 0..1439. Returns a
+// dynamically allocated REPLAY; free it with freeReplay().
+//
+struct REPLAY* replayEvents(struct EVENT* sorted, int count, int* capacities, int stationCount);
+
+void freeReplay(struct REPLAY* replay);
@@ -0,0 +1,451 @@
+/*sketch.c*/
+
+//
+// Fixed-size streaming sketches for approximate analytics over
+// trips files too large to hold in memory.
+//
+// Author:
+// Aarya Patel
+//
+// Northwestern University
+// DIVVY Data analysis
+//
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "sketch.h"
+
+
+//
+// hashing
+//
+
+uint64_t hashMix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t hashString(const char* s) {
+    uint64_t h = 0xcbf29ce484222325ULL; // FNV-1a offset basis
+
+    for (; *s != '\0'; s++) {
+        h ^= (unsigned char)*s;
+        h *= 0x100000001b3ULL;            // FNV-1a prime
+    }
+
+    return hashMix(h);
+}
+
+
+//
+// HyperLogLog
+//
+
+struct HLL* hllCreate(int precision) {
+    struct HLL* hll = malloc(sizeof(struct HLL));
+    hll->precision = precision;
+    hll->m = 1 << precision;
+    hll->registers = calloc(hll->m, sizeof(unsigned char));
+    return hll;
+}
+
+//
+// the top precision bits pick a register; the register keeps the
+// longest run of leading zeros (+1) seen in the remaining bits
+//
+void hllAdd(struct HLL* hll, uint64_t hash) {
+    int index = (int)(hash >> (64 - hll->precision));
+    uint64_t rest = hash << hll->precision;
+    int maxRank = 64 - hll->precision + 1;
+
+    int rank = 1;
+    while (rank < maxRank && (rest & 0x8000000000000000ULL) == 0) {
+        rest <<= 1;
+        rank++;
+    }
+
+    if (rank > hll->registers[index]) {
+        hll->registers[index] = (unsigned char)rank;
+    }
+}
+
+//
+// sigma and tau correction terms of Ertl's improved estimator, for
+// registers that are still zero and registers that are saturated
+//
+static double hllSigma(double x) {
+    if (x == 1.0) return INFINITY;
+
+    double y = 1.0;
+    double z = x;
+    double previous;
+    do {
+        x *= x;
+        previous = z;
+        z += x * y;
+        y += y;
+    } while (z != previous);
+
+    return z;
+}
+
+static double hllTau(double x) {
+    if (x == 0.0 || x == 1.0) return 0.0;
+
+    double y = 1.0;
+    double z = 1.0 - x;
+    double previous;
+    do {
+        x = sqrt(x);
+        previous = z;
+        y *= 0.5;
+        z -= (1.0 - x) * (1.0 - x) * y;
+    } while (z != previous);
+
+    return z / 3.0;
+}
+
+//
+// hllEstimate
+//
+// uses Ertl's improved estimator ("New cardinality estimation
+// algorithms for HyperLogLog sketches", 2017) rather than the original
+// raw estimate with a linear counting switch, since the latter is
+// biased by several percent just above the switch-over point
+//
+double hllEstimate(struct HLL* hll) {
+    int maxRank = 64 - hll->precision + 1;
+    int histogram[66] = {0};
+
+    for (int i = 0; i < hll->m; i++) {
+        histogram[hll->registers[i]]++;
+    }
+
+    double m = hll->m;
+    double z = m * hllTau(1.0 - histogram[maxRank] / m);
+    for (int k = maxRank - 1; k >= 1; k--) {
+        z = 0.5 * (z + histogram[k]);
+    }
+    z += m * hllSigma(histogram[0] / m);
+
+    return 0.5 / log(2.0) * m * m / z;
+}
+
+double hllRelativeError(struct HLL* hll) {
+    return 1.04 / sqrt((double)hll->m);
+}
+
+void hllFree(struct HLL* hll) {
+    if (hll == NULL) return;
+    free(hll->registers);
+    free(hll);
+}
+
+
+//
+// t-digest
+//
+
+static const double PI = 3.14159265358979323846;
+
+//
+// k1 scale function and its inverse: maps a quantile q to a scale
+// k, where each centroid may span at most one unit of k
+//
+static double tdigestK(double q, double compression) {
+    return compression / (2.0 * PI) * asin(2.0 * q - 1.0);
+}
+
+static double tdigestQ(double k, double compression) {
+    if (k >= compression / 4.0) return 1.0;
+    return (sin(k * 2.0 * PI / compression) + 1.0) / 2.0;
+}
+
+static int compareCentroids(const void* a, const void* b) {
+    const struct CENTROID* centroidA = (const struct CENTROID*)a;
+    const struct CENTROID* centroidB = (const struct CENTROID*)b;
+
+    if (centroidA->mean < centroidB->mean) return -1;
+    if (centroidA->mean > centroidB->mean) return 1;
+    return 0;
+}
+
+struct TDIGEST* tdigestCreate(double compression) {
+    struct TDIGEST* td = malloc(sizeof(struct TDIGEST));
+    int centroidCapacity = 2 * (int)ceil(compression) + 10;
+
+    td->compression = compression;
+    td->centroids = malloc(centroidCapacity * sizeof(struct CENTROID));
+    td->centroidCount = 0;
+    td->bufferCapacity = 5 * (int)ceil(compression);
+    td->buffer = malloc(td->bufferCapacity * sizeof(struct CENTROID));
+    td->bufferCount = 0;
+    td->scratch = malloc((centroidCapacity + td->bufferCapacity) * sizeof(struct CENTROID));
+    td->totalWeight = 0.0;
+    td->min = INFINITY;
+    td->max = -INFINITY;
+    return td;
+}
+
+//
+// tdigestCompress
+//
+// merges the buffered points into the centroids: sorts everything by
+// mean and greedily combines neighbours while the combined centroid
+// still spans at most one unit of the scale function
+//
+static void tdigestCompress(struct TDIGEST* td) {
+    if (td->bufferCount == 0) return;
+
+    int n = 0;
+    for (int i = 0; i < td->centroidCount; i++) {
+        td->scratch[n++] = td->centroids[i];
+    }
+    for (int i = 0; i < td->bufferCount; i++) {
+        td->scratch[n++] = td->buffer[i];
+    }
+    td->bufferCount = 0;
+
+    qsort(td->scratch, n, sizeof(struct CENTROID), compareCentroids);
+
+    double total = td->totalWeight;
+    double weightSoFar = 0.0;
+    double weightLimit = total * tdigestQ(tdigestK(0.0, td->compression) + 1.0, td->compression);
+    struct CENTROID current = td->scratch[0];
+    int count = 0;
+
+    for (int i = 1; i < n; i++) {
+        struct CENTROID next = td->scratch[i];
+
+        if (weightSoFar + current.weight + next.weight <= weightLimit) {
+            double weight = current.weight + next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / weight;
+            current.weight = weight;
+        }
+        else {
+            weightSoFar += current.weight;
+            td->centroids[count++] = current;
+            double k = tdigestK(weightSoFar / total, td->compression);
+            weightLimit = total * tdigestQ(k + 1.0, td->compression);
+            current = next;
+        }
+    }
+
+    td->centroids[count++] = current;
+    td->centroidCount = count;
+}
+
+void tdigestAdd(struct TDIGEST* td, double x) {
+    if (td->bufferCount >= td->bufferCapacity) {
+        tdigestCompress(td);
+    }
+
+    td->buffer[td->bufferCount].mean = x;
+    td->buffer[td->bufferCount].weight = 1.0;
+    td->bufferCount++;
+    td->totalWeight += 1.0;
+
+    if (x < td->min) td->min = x;
+    if (x > td->max) td->max = x;
+}
+
+//
+// tdigestQuantile
+//
+// returns the estimated value at quantile q (0..1), interpolating
+// linearly between centroid centers, and between the outermost
+// centroids and the exact min / max. Returns NAN if nothing was added.
+//
+double tdigestQuantile(struct TDIGEST* td, double q) {
+    tdigestCompress(td);
+
+    if (td->centroidCount == 0) return NAN;
+    if (q <= 0.0) return td->min;
+    if (q >= 1.0) return td->max;
+
+    struct CENTROID* c = td->centroids;
+    int n = td->centroidCount;
+    double target = q * td->totalWeight;
+
+    // left tail: between min and the center of the first centroid
+    if (target < c[0].weight / 2.0) {
+        return td->min + (c[0].mean - td->min) * target / (c[0].weight / 2.0);
+    }
+
+    double weightSoFar = 0.0;
+    for (int i = 0; i < n - 1; i++) {
+        double leftCenter = weightSoFar + c[i].weight / 2.0;
+        double rightCenter = weightSoFar + c[i].weight + c[i + 1].weight / 2.0;
+
+        if (target < rightCenter) {
+            double t = (target - leftCenter) / (rightCenter - leftCenter);
+            return c[i].mean + (c[i + 1].mean - c[i].mean) * t;
+        }
+        weightSoFar += c[i].weight;
+    }
+
+    // right tail: between the center of the last centroid and max
+    double lastCenter = weightSoFar + c[n - 1].weight / 2.0;
+    double t = (target - lastCenter) / (td->totalWeight - lastCenter);
+    return c[n - 1].mean + (td->max - c[n - 1].mean) * t;
+}
+
+void tdigestFree(struct TDIGEST* td) {
+    if (td == NULL) return;
+    free(td->centroids);
+    free(td->buffer);
+    free(td->scratch);
+    free(td);
+}
+
+
+//
+// count-min
+//
+
+struct CMS* cmsCreate(int width, int depth) {
+    struct CMS* cms = malloc(sizeof(struct CMS));
+    cms->width = width;
+    cms->depth = depth;
+    cms->counts = calloc((size_t)width * depth, sizeof(uint32_t));
+    cms->total = 0;
+    return cms;
+}
+
+//
+// row i uses hash h1 + i * h2 (Kirsch-Mitzenmacher double hashing),
+// so one 64-bit hash is enough for every row
+//
+static int cmsColumn(struct CMS* cms, uint64_t hash, int row) {
+    uint32_t h1 = (uint32_t)hash;
+    uint32_t h2 = (uint32_t)(hash >> 32) | 1;
+    return (int)((h1 + (uint32_t)row * h2) % (uint32_t)cms->width);
+}
+
+//
+// cmsAdd
+//
+// counts one occurrence and returns the updated estimate
+//
+uint32_t cmsAdd(struct CMS* cms, uint64_t hash) {
+    uint32_t estimate = UINT32_MAX;
+
+    for (int row = 0; row < cms->depth; row++) {
+        uint32_t* counter = &cms->counts[(size_t)row * cms->width + cmsColumn(cms, hash, row)];
+        (*counter)++;
+        if (*counter < estimate) {
+            estimate = *counter;
+        }
+    }
+
+    cms->total++;
+    return estimate;
+}
+
+uint32_t cmsEstimate(struct CMS* cms, uint64_t hash) {
+    uint32_t estimate = UINT32_MAX;
+
+    for (int row = 0; row < cms->depth; row++) {
+        uint32_t counter = cms->counts[(size_t)row * cms->width + cmsColumn(cms, hash, row)];
+        if (counter < estimate) {
+            estimate = counter;
+        }
+    }
+
+    return estimate;
+}
+
+//
+// cmsErrorBound
+//
+// returns the amount (e / width) * N by which an estimate may exceed
+// the true count with probability 1 - exp(-depth)
+//
+double cmsErrorBound(struct CMS* cms) {
+    return exp(1.0) / cms->width * (double)cms->total;
+}
+
+void cmsFree(struct CMS* cms) {
+    if (cms == NULL) return;
+    free(cms->counts);
+    free(cms);
+}
+
+
+//
+// top-k
+//
+
+struct TOPK* topkCreate(int k) {
+    struct TOPK* topk = malloc(sizeof(struct TOPK));
+    topk->k = k;
+    topk->count = 0;
+    topk->keys = malloc(k * sizeof(uint64_t));
+    topk->estimates = malloc(k * sizeof(uint32_t));
+    return topk;
+}
+
+//
+// topkOffer
+//
+// updates the key if it is already tracked; otherwise adds it while
+// there is room, or replaces the smallest tracked key if this
+// estimate is larger. k is small, so a linear scan is fine.
+//
+void topkOffer(struct TOPK* topk, uint64_t key, uint32_t estimate) {
+    int smallest = 0;
+
+    for (int i = 0; i < topk->count; i++) {
+        if (topk->keys[i] == key) {
+            topk->estimates[i] = estimate;
+            return;
+        }
+        if (topk->estimates[i] < topk->estimates[smallest]) {
+            smallest = i;
+        }
+    }
+
+    if (topk->count < topk->k) {
+        topk->keys[topk->count] = key;
+        topk->estimates[topk->count] = estimate;
+        topk->count++;
+    }
+    else if (estimate > topk->estimates[smallest]) {
+        topk->keys[smallest] = key;
+        topk->estimates[smallest] = estimate;
+    }
+}
+
+//
+// topkSort
+//
+// orders the tracked keys by estimate, largest first (ties by key)
+//
+void topkSort(struct TOPK* topk) {
+    for (int i = 1; i < topk->count; i++) {
+        uint64_t key = topk->keys[i];
+        uint32_t estimate = topk->estimates[i];
+        int j = i - 1;
+
+        while (j >= 0 && (topk->estimates[j] < estimate ||
+                                            (topk->estimates[j] == estimate && topk->keys[j] > key))) {
+            topk->keys[j + 1] = topk->keys[j];
+            topk->estimates[j + 1] = topk->estimates[j];
+            j--;
+        }
+        topk->keys[j + 1] = key;
+        topk->estimates[j + 1] = estimate;
+    }
+}
+
+void topkFree(struct TOPK* topk) {
+    if (topk == NULL) return;
+    free(topk->keys);
+    free(topk->estimates);
+    free(topk);
+}
@@ -0,0 +1,138 @@
+/*sketch.h*/
+
+//
+// Fixed-size streaming sketches for approximate analytics over
+// trips files too large to hold in memory. Every sketch uses a
+// constant amount of memory no matter how many items are added.
+//
+// Author:
+// Aarya Patel
+//
+// Northwestern University
+// DIVVY Data analysis
+//
+
+#pragma once
+
+#include <stdint.h>
+
+
+//
+// hashing
+//
+
+//
+// hashString
+//
+// Returns a well mixed 64-bit hash of the given string (FNV-1a
+// followed by a splitmix64 finalizer). Sketches need hash bits
+// that look uniformly random, which plain FNV-1a does not give.
+//
+uint64_t hashString(const char* s);
+
+//
+// hashMix
+//
+// Scrambles a 64-bit integer key (splitmix64 finalizer), e.g. to
+// hash a pair of station indices packed into one integer.
+//
+uint64_t hashMix(uint64_t x);
+
+
+//
+// HyperLogLog: distinct counts
+//
+// Uses 2^precision one-byte registers. The relative standard error
+// (one sigma, about 68% confidence) of the estimate is about
+// 1.04 / sqrt(2^precision), e.g. 0.81% at precision 14 (16KB) and
+// 3.25% at precision 10 (1KB); twice that bounds the error with about
+// 95% confidence.
+//
+struct HLL {
+    int precision;
+    int m;
+    unsigned char* registers;
+};
+
+struct HLL* hllCreate(int precision);
+void hllAdd(struct HLL* hll, uint64_t hash);
+double hllEstimate(struct HLL* hll);
+double hllRelativeError(struct HLL* hll);   // one standard error
+void hllFree(struct HLL* hll);
+
+
+//
+// t-digest: quantiles
+//
+// Merging t-digest with the arcsine (k1) scale function, so
+// centroids are small near the tails and large in the middle.
+// Holds at most about compression centroids; at compression 100
+// quantile estimates are typically within 1% in rank in the middle
+// of the distribution and much closer near the extremes. Min and
+// max are tracked exactly.
+//
+struct CENTROID {
+    double mean;
+    double weight;
+};
+
+struct TDIGEST {
+    double compression;
+    struct CENTROID* centroids;
+    int centroidCount;
+    struct CENTROID* buffer;
+    int bufferCount;
+    int bufferCapacity;
+    struct CENTROID* scratch;
+    double totalWeight;
+    double min;
+    double max;
+};
+
+struct TDIGEST* tdigestCreate(double compression);
+void tdigestAdd(struct TDIGEST* td, double x);
+double tdigestQuantile(struct TDIGEST* td, double q);
+void tdigestFree(struct TDIGEST* td);
+
+
+//
+// count-min: frequencies
+//
+// A depth x width table of counters. An estimate never undercounts,
+// and overcounts by at most (e / width) * N with probability
+// 1 - exp(-depth), where N is the total count added. At width 2048
+// and depth 4 that is 0.13% of N with 98% confidence.
+//
+struct CMS {
+    int width;
+    int depth;
+    uint32_t* counts;
+    uint64_t total;
+};
+
+struct CMS* cmsCreate(int width, int depth);
+uint32_t cmsAdd(struct CMS* cms, uint64_t hash);
+uint32_t cmsEstimate(struct CMS* cms, uint64_t hash);
+double cmsErrorBound(struct CMS* cms);
+void cmsFree(struct CMS* cms);
+
+
+//
+// top-k: heaviest keys
+//
+// Keeps the k keys with the largest count-min estimates seen so far,
+// so the heavy hitters of a stream can be reported without storing
+// every key. Each key is offered with its estimate after it is added
+// to the count-min sketch.
+//
+struct TOPK {
+    int k;
+    int count;
+    uint64_t* keys;
+    uint32_t* estimates;
+};
+
+struct TOPK* topkCreate(int k);
+void topkOffer(struct TOPK* topk, uint64_t key, uint32_t estimate);
+void topkSort(struct TOPK* topk);
+void topkFree(struct TOPK* topk);